@@ -0,0 +1,155 @@
+# CMake profile-guided optimization driver script
+#
+# Builds a baseline, an instrumented build and a PGO+LTO build of the plugin, trains the instrumented build with
+# trim-benchmark and reports the benchmark deltas between the baseline and the optimized build.
+#
+# Usage (from the source directory):
+#   cmake -DPGO_PRESET=macos -P cmake/common/pgo-build.cmake
+#   cmake -DPGO_PRESET=windows-x64 "-DPGO_CONFIGURE_ARGS=-T;ClangCL" -P cmake/common/pgo-build.cmake
+#
+# Optional variables:
+#   PGO_CONFIG           Build configuration (default: RelWithDebInfo)
+#   PGO_BINARY_DIR       Root directory for the three build trees (default: <source>/build_pgo)
+#   PGO_ITERATIONS       Timed iterations per workload for the reported deltas (default: 5)
+#   PGO_TRAINING_INPUTS  Additional recordings to trim during training and benchmarking
+#   PGO_CONFIGURE_ARGS   Extra arguments passed to every configure step
+
+cmake_minimum_required(VERSION 3.28...3.30)
+
+if(NOT PGO_PRESET)
+  message(FATAL_ERROR "PGO_PRESET is required (e.g. -DPGO_PRESET=macos or -DPGO_PRESET=windows-x64).")
+endif()
+
+get_filename_component(_pgo_source_dir "${CMAKE_CURRENT_LIST_DIR}/../.." ABSOLUTE)
+
+if(NOT PGO_CONFIG)
+  set(PGO_CONFIG RelWithDebInfo)
+endif()
+if(NOT PGO_BINARY_DIR)
+  set(PGO_BINARY_DIR "${_pgo_source_dir}/build_pgo")
+endif()
+if(NOT PGO_ITERATIONS)
+  set(PGO_ITERATIONS 5)
+endif()
+
+set(_pgo_baseline_dir "${PGO_BINARY_DIR}/baseline")
+set(_pgo_instrument_dir "${PGO_BINARY_DIR}/instrument")
+set(_pgo_optimize_dir "${PGO_BINARY_DIR}/optimize")
+set(_pgo_profile_dir "${PGO_BINARY_DIR}/profiles")
+set(_pgo_work_dir "${PGO_BINARY_DIR}/work")
+set(_pgo_profile "${PGO_BINARY_DIR}/trim-benchmark.profdata")
+
+# _pgo_cache_value: Read a single entry from a build tree's CMakeCache.txt
+function(_pgo_cache_value build_dir entry out_var)
+  file(STRINGS "${build_dir}/CMakeCache.txt" _line REGEX "^${entry}:[A-Z]+=")
+  string(REGEX REPLACE "^${entry}:[A-Z]+=" "" _value "${_line}")
+  set(${out_var} "${_value}" PARENT_SCOPE)
+endfunction()
+
+# _pgo_configure_and_build: Configure a build tree from the preset and build all targets
+function(_pgo_configure_and_build label build_dir)
+  message(STATUS "Configure ${label} build")
+  execute_process(
+    COMMAND "${CMAKE_COMMAND}" --preset ${PGO_PRESET} -B "${build_dir}" ${PGO_CONFIGURE_ARGS} ${ARGN}
+    WORKING_DIRECTORY "${_pgo_source_dir}"
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+
+  message(STATUS "Build ${label} build (${PGO_CONFIG})")
+  execute_process(
+    COMMAND "${CMAKE_COMMAND}" --build "${build_dir}" --config ${PGO_CONFIG} --parallel
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+  message(STATUS "Build ${label} build (${PGO_CONFIG}) - done")
+endfunction()
+
+# _pgo_run_benchmark: Run trim-benchmark from a build tree, forwarding any extra arguments
+function(_pgo_run_benchmark build_dir)
+  file(READ "${build_dir}/trim-benchmark-${PGO_CONFIG}.path" _benchmark)
+
+  # Runtime dependencies live in the dependency tree and are not copied next to the executable. On macOS the
+  # target carries RPATHs for them; the loader paths are a fallback in case a dependency is not @rpath-relative.
+  _pgo_cache_value("${build_dir}" CMAKE_PREFIX_PATH _prefix_path)
+  foreach(_prefix IN LISTS _prefix_path)
+    if(CMAKE_HOST_WIN32)
+      file(TO_NATIVE_PATH "${_prefix}/bin" _prefix_bin)
+      set(ENV{PATH} "${_prefix_bin};$ENV{PATH}")
+    elseif(CMAKE_HOST_APPLE)
+      set(ENV{DYLD_FRAMEWORK_PATH} "${_prefix}/Frameworks:${_prefix}:$ENV{DYLD_FRAMEWORK_PATH}")
+      set(ENV{DYLD_LIBRARY_PATH} "${_prefix}/lib:$ENV{DYLD_LIBRARY_PATH}")
+    endif()
+  endforeach()
+
+  execute_process(
+    COMMAND "${_benchmark}" --work-dir "${_pgo_work_dir}" ${ARGN} ${PGO_TRAINING_INPUTS}
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+endfunction()
+
+_pgo_configure_and_build(baseline "${_pgo_baseline_dir}" -DENABLE_TRIM_BENCHMARK=ON -DENABLE_PGO=OFF)
+_pgo_configure_and_build(instrumented "${_pgo_instrument_dir}" -DENABLE_PGO=ON -DPGO_PHASE=GENERATE)
+
+# Training run: coverage matters here, not timing
+message(STATUS "Collect training profile")
+file(REMOVE_RECURSE "${_pgo_profile_dir}")
+file(MAKE_DIRECTORY "${_pgo_profile_dir}")
+set(ENV{LLVM_PROFILE_FILE} "${_pgo_profile_dir}/trim-benchmark-%p.profraw")
+_pgo_run_benchmark("${_pgo_instrument_dir}" --iterations 2)
+unset(ENV{LLVM_PROFILE_FILE})
+
+file(GLOB _pgo_raw_profiles "${_pgo_profile_dir}/*.profraw")
+if(NOT _pgo_raw_profiles)
+  message(FATAL_ERROR "Training run produced no .profraw files in ${_pgo_profile_dir}")
+endif()
+
+if(CMAKE_HOST_APPLE)
+  execute_process(
+    COMMAND xcrun --find llvm-profdata
+    OUTPUT_VARIABLE LLVM_PROFDATA
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+else()
+  _pgo_cache_value("${_pgo_instrument_dir}" CMAKE_CXX_COMPILER _pgo_compiler)
+  get_filename_component(_pgo_compiler_dir "${_pgo_compiler}" DIRECTORY)
+  find_program(LLVM_PROFDATA llvm-profdata HINTS "${_pgo_compiler_dir}" REQUIRED)
+endif()
+
+execute_process(
+  COMMAND "${LLVM_PROFDATA}" merge "-output=${_pgo_profile}" ${_pgo_raw_profiles}
+  COMMAND_ERROR_IS_FATAL ANY
+)
+message(STATUS "Collect training profile - done (${_pgo_profile})")
+
+_pgo_configure_and_build(
+  optimized
+  "${_pgo_optimize_dir}"
+  -DENABLE_PGO=ON
+  -DPGO_PHASE=USE
+  "-DPGO_PROFILE=${_pgo_profile}"
+)
+
+# Timed runs happen back to back after all builds so both see the same machine state
+message(STATUS "Benchmark baseline build")
+_pgo_run_benchmark("${_pgo_baseline_dir}" --iterations ${PGO_ITERATIONS} --report "${PGO_BINARY_DIR}/baseline.csv")
+message(STATUS "Benchmark optimized build")
+_pgo_run_benchmark("${_pgo_optimize_dir}" --iterations ${PGO_ITERATIONS} --report "${PGO_BINARY_DIR}/optimized.csv")
+
+file(READ "${_pgo_optimize_dir}/trim-benchmark-${PGO_CONFIG}.path" _pgo_benchmark)
+execute_process(
+  COMMAND "${_pgo_benchmark}" --compare "${PGO_BINARY_DIR}/baseline.csv" "${PGO_BINARY_DIR}/optimized.csv"
+  OUTPUT_VARIABLE _pgo_deltas
+  COMMAND_ERROR_IS_FATAL ANY
+)
+
+string(TIMESTAMP _pgo_timestamp "%Y-%m-%d %H:%M")
+file(
+  WRITE "${PGO_BINARY_DIR}/pgo-report.md"
+  "# PGO+LTO trim benchmark (${PGO_PRESET}, ${PGO_CONFIG}, ${_pgo_timestamp})\n\n"
+  "Median of ${PGO_ITERATIONS} runs per workload; negative deltas are faster.\n\n"
+  "${_pgo_deltas}"
+)
+
+message(STATUS "Benchmark deltas (baseline -> PGO+LTO):\n${_pgo_deltas}")
+message(STATUS "Report written to ${PGO_BINARY_DIR}/pgo-report.md")
+message(STATUS "Optimized plugin: ${_pgo_optimize_dir}/rundir/${PGO_CONFIG}")
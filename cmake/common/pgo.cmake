@@ -0,0 +1,80 @@
+# CMake profile-guided optimization module
+
+include_guard(GLOBAL)
+
+option(ENABLE_PGO "Build with profile-guided and link-time optimization" OFF)
+set(PGO_PHASE "USE" CACHE STRING "Profile-guided optimization phase (GENERATE or USE)")
+set_property(CACHE PGO_PHASE PROPERTY STRINGS GENERATE USE)
+set(PGO_PROFILE "" CACHE FILEPATH "Merged .profdata file used when PGO_PHASE is USE")
+# Sources the trim-benchmark training run executes. Widen this when using a profile captured from a real OBS session.
+set(
+  PGO_PROFILED_SOURCES
+  "src/utils/video-trimmer.cpp;src/utils/output-pool.cpp"
+  CACHE STRING
+  "Sources compiled with the profile when PGO_PHASE is USE"
+)
+
+if(ENABLE_PGO)
+  # Clang instrumentation profiles are keyed by function, so a profile collected from trim-benchmark applies to the
+  # same sources compiled into the plugin. MSVC profiles are tied to a single image and cannot be shared that way.
+  if(NOT CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    message(
+      FATAL_ERROR
+      "ENABLE_PGO requires a Clang toolchain (AppleClang on macOS, ClangCL on Windows via '-T ClangCL'). "
+      "Current compiler: ${CMAKE_CXX_COMPILER_ID}"
+    )
+  endif()
+
+  if(NOT PGO_PHASE MATCHES "^(GENERATE|USE)$")
+    message(FATAL_ERROR "PGO_PHASE must be GENERATE or USE (got '${PGO_PHASE}').")
+  endif()
+
+  if(PGO_PHASE STREQUAL "USE" AND NOT EXISTS "${PGO_PROFILE}")
+    message(
+      FATAL_ERROR
+      "PGO_PHASE=USE requires PGO_PROFILE to point at a merged .profdata file. "
+      "Use 'cmake -DPGO_PRESET=<preset> -P cmake/common/pgo-build.cmake' to run the full training pipeline."
+    )
+  endif()
+
+  include(CheckIPOSupported)
+  check_ipo_supported(RESULT _pgo_ipo_supported OUTPUT _pgo_ipo_output LANGUAGES CXX)
+  if(PGO_PHASE STREQUAL "USE" AND NOT _pgo_ipo_supported)
+    message(WARNING "Link-time optimization is not supported by this toolchain, building with PGO only: ${_pgo_ipo_output}")
+  endif()
+
+  message(STATUS "Profile-guided optimization enabled (phase: ${PGO_PHASE})")
+  message(
+    STATUS
+    "Profile-guided optimization applies to ${PGO_PROFILED_SOURCES}; "
+    "FFmpeg and libobs are prebuilt and are not profiled"
+  )
+endif()
+
+# target_enable_pgo: Apply the flags for the configured PGO phase to a target
+function(target_enable_pgo target)
+  if(NOT ENABLE_PGO)
+    return()
+  endif()
+
+  if(PGO_PHASE STREQUAL "GENERATE")
+    target_compile_options(${target} PRIVATE -fprofile-instr-generate)
+    # clang-cl embeds the profile runtime as a default library, the GNU-style driver needs the flag at link time
+    if(NOT CMAKE_CXX_COMPILER_FRONTEND_VARIANT STREQUAL "MSVC")
+      target_link_options(${target} PRIVATE -fprofile-instr-generate)
+    endif()
+  else()
+    # The profile only has data for code the training run executes. Applying it to the UI and manager sources would
+    # print an unprofiled warning for each of them on every build, so it is limited to PGO_PROFILED_SOURCES. Clang's
+    # default -Wprofile-instr-unprofiled and -Wprofile-instr-out-of-date still flag a listed source the profile
+    # does not match.
+    set_source_files_properties(
+      ${PGO_PROFILED_SOURCES}
+      TARGET_DIRECTORY ${target}
+      PROPERTIES COMPILE_OPTIONS "-fprofile-instr-use=${PGO_PROFILE}" OBJECT_DEPENDS "${PGO_PROFILE}"
+    )
+    if(_pgo_ipo_supported)
+      set_property(TARGET ${target} PROPERTY INTERPROCEDURAL_OPTIMIZATION TRUE)
+    endif()
+  endif()
+endfunction()
@@ -0,0 +1,606 @@
+/**
+ * @file trim-benchmark.cpp
+ * @brief Standalone trim benchmark and PGO training workload
+ *
+ * Generates a synthetic replay fixture with libavformat, then repeatedly trims
+ * it (and any recordings passed on the command line) through VideoTrimmer so
+ * the stream-copy path can be timed and profiled outside of OBS. A second mode
+ * compares two CSV reports and prints the per-workload deltas.
+ *
+ * Every workload is timed twice: once with the trimmer creating its output
+ * ("direct") and once writing into an OutputPool file prepared in the work
+ * directory ("prewarmed"), the way saves run while the replay buffer is active.
+ */
+
+#include "utils/video-trimmer.hpp"
+#include "utils/output-pool.hpp"
+
+// OBS includes
+#include <util/base.h>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/pixfmt.h>
+#include <libavutil/samplefmt.h>
+}
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+  // Synthetic fixture: raw video + PCM audio so no encoder is required, with a
+  // keyframe cadence similar to a typical OBS encoder configuration
+  constexpr int FIXTURE_SECONDS = 120;
+  constexpr int FIXTURE_FPS = 60;
+  constexpr int FIXTURE_GOP = 120; // 2 second keyframe interval
+  constexpr int FIXTURE_WIDTH = 64;
+  constexpr int FIXTURE_HEIGHT = 36;
+  constexpr int FIXTURE_SAMPLE_RATE = 48000;
+  constexpr int FIXTURE_AUDIO_FRAME = 1024;
+  constexpr int FIXTURE_CHANNELS = 2;
+  constexpr const char *FIXTURE_NAME = "synthetic.mkv";
+
+  // Trim lengths exercised per fixture (seconds)
+  constexpr int TRIM_DURATIONS[] = {5, 15, 30, 60};
+  constexpr int DEFAULT_ITERATIONS = 5;
+
+  // Output paths timed per workload
+  constexpr const char *PATH_DIRECT = "direct";
+  constexpr const char *PATH_PREWARMED = "prewarmed";
+  constexpr auto POOL_READY_TIMEOUT = std::chrono::seconds(10);
+
+  struct Options
+  {
+    int iterations = DEFAULT_ITERATIONS;
+    fs::path workDir = fs::temp_directory_path() / "replay-buffer-pro-bench";
+    std::string reportPath;
+    std::string compareBaseline;
+    std::string compareCandidate;
+    std::vector<std::string> inputs;
+    std::vector<std::string> paths = {PATH_DIRECT, PATH_PREWARMED};
+    bool verbose = false;
+  };
+
+  struct Result
+  {
+    std::string fixture;
+    int duration = 0;
+    std::string path;
+    int iterations = 0;
+    double medianMs = 0.0;
+    double meanMs = 0.0;
+    double minMs = 0.0;
+  };
+
+  //=============================================================================
+  // HELPERS
+  //=============================================================================
+
+  void quietLogHandler(int level, const char *format, va_list args, void *)
+  {
+    // Trimmer info logs would dominate the timings; keep warnings and errors only
+    if (level > LOG_WARNING)
+    {
+      return;
+    }
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+  }
+
+  void printUsage(const char *program)
+  {
+    printf("Usage: %s [--iterations N] [--work-dir DIR] [--report FILE] [--path direct|prewarmed]\n"
+           "          [--verbose] [input...]\n"
+           "       %s --compare BASELINE.csv CANDIDATE.csv\n",
+           program, program);
+  }
+
+  bool parseOptions(int argc, char **argv, Options &options)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      bool hasValue = i + 1 < argc;
+
+      if (arg == "--iterations" && hasValue)
+      {
+        options.iterations = std::max(1, atoi(argv[++i]));
+      }
+      else if (arg == "--work-dir" && hasValue)
+      {
+        options.workDir = argv[++i];
+      }
+      else if (arg == "--report" && hasValue)
+      {
+        options.reportPath = argv[++i];
+      }
+      else if (arg == "--path" && hasValue)
+      {
+        std::string path = argv[++i];
+        if (path != PATH_DIRECT && path != PATH_PREWARMED)
+        {
+          return false;
+        }
+        options.paths = {path};
+      }
+      else if (arg == "--compare" && i + 2 < argc)
+      {
+        options.compareBaseline = argv[++i];
+        options.compareCandidate = argv[++i];
+      }
+      else if (arg == "--verbose")
+      {
+        options.verbose = true;
+      }
+      else if (arg.rfind("--", 0) == 0)
+      {
+        return false;
+      }
+      else
+      {
+        options.inputs.push_back(arg);
+      }
+    }
+    return true;
+  }
+
+  //=============================================================================
+  // SYNTHETIC FIXTURE
+  //=============================================================================
+
+  bool writeFixturePacket(AVFormatContext *ctx, AVPacket *packet, AVStream *stream,
+                          AVRational timeBase, int64_t pts, int64_t duration,
+                          int size, bool keyframe)
+  {
+    if (av_new_packet(packet, size) < 0)
+    {
+      return false;
+    }
+
+    memset(packet->data, static_cast<int>(pts & 0xff), size);
+    packet->stream_index = stream->index;
+    packet->pts = pts;
+    packet->dts = pts;
+    packet->duration = duration;
+    if (keyframe)
+    {
+      packet->flags |= AV_PKT_FLAG_KEY;
+    }
+    av_packet_rescale_ts(packet, timeBase, stream->time_base);
+
+    // Takes ownership of the packet data and leaves the packet blank
+    return av_interleaved_write_frame(ctx, packet) >= 0;
+  }
+
+  bool writeSyntheticFixture(const std::string &path)
+  {
+    AVFormatContext *ctx = nullptr;
+    if (avformat_alloc_output_context2(&ctx, nullptr, "matroska", path.c_str()) < 0 || !ctx)
+    {
+      fprintf(stderr, "Could not create fixture muxer for '%s'\n", path.c_str());
+      return false;
+    }
+
+    const AVRational videoTimeBase = {1, FIXTURE_FPS};
+    const AVRational audioTimeBase = {1, FIXTURE_SAMPLE_RATE};
+
+    AVStream *video = avformat_new_stream(ctx, nullptr);
+    AVStream *audio = avformat_new_stream(ctx, nullptr);
+    if (!video || !audio)
+    {
+      avformat_free_context(ctx);
+      return false;
+    }
+
+    video->time_base = videoTimeBase;
+    video->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    video->codecpar->codec_id = AV_CODEC_ID_RAWVIDEO;
+    video->codecpar->codec_tag = avcodec_pix_fmt_to_codec_tag(AV_PIX_FMT_YUV420P);
+    video->codecpar->format = AV_PIX_FMT_YUV420P;
+    video->codecpar->width = FIXTURE_WIDTH;
+    video->codecpar->height = FIXTURE_HEIGHT;
+
+    audio->time_base = audioTimeBase;
+    audio->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
+    audio->codecpar->codec_id = AV_CODEC_ID_PCM_S16LE;
+    audio->codecpar->format = AV_SAMPLE_FMT_S16;
+    audio->codecpar->sample_rate = FIXTURE_SAMPLE_RATE;
+    audio->codecpar->bits_per_coded_sample = 16;
+    audio->codecpar->block_align = FIXTURE_CHANNELS * 2;
+    av_channel_layout_default(&audio->codecpar->ch_layout, FIXTURE_CHANNELS);
+
+    bool success = avio_open(&ctx->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0 &&
+                   avformat_write_header(ctx, nullptr) >= 0;
+
+    AVPacket *packet = av_packet_alloc();
+    success = success && packet;
+
+    const int64_t frameCount = static_cast<int64_t>(FIXTURE_SECONDS) * FIXTURE_FPS;
+    const int videoSize = FIXTURE_WIDTH * FIXTURE_HEIGHT * 3 / 2;
+    const int audioSize = FIXTURE_AUDIO_FRAME * FIXTURE_CHANNELS * 2;
+    int64_t audioPts = 0;
+
+    for (int64_t frame = 0; success && frame < frameCount; frame++)
+    {
+      success = writeFixturePacket(ctx, packet, video, videoTimeBase, frame, 1,
+                                   videoSize, frame % FIXTURE_GOP == 0);
+
+      // Keep audio interleaved up to the next video frame
+      while (success && av_compare_ts(audioPts, audioTimeBase, frame + 1, videoTimeBase) < 0)
+      {
+        success = writeFixturePacket(ctx, packet, audio, audioTimeBase, audioPts,
+                                     FIXTURE_AUDIO_FRAME, audioSize, true);
+        audioPts += FIXTURE_AUDIO_FRAME;
+      }
+    }
+
+    if (success)
+    {
+      success = av_write_trailer(ctx) >= 0;
+    }
+    if (!success)
+    {
+      fprintf(stderr, "Failed to write synthetic fixture '%s'\n", path.c_str());
+    }
+
+    av_packet_free(&packet);
+    avio_closep(&ctx->pb);
+    avformat_free_context(ctx);
+    return success;
+  }
+
+  //=============================================================================
+  // BENCHMARK
+  //=============================================================================
+
+  /**
+   * @brief Captures the input's streams as the profile a pool would get from the encoders
+   */
+  bool probeProfile(const std::string &input, const Options &options, ReplayBufferPro::MuxerProfile &profile)
+  {
+    AVFormatContext *ctx = nullptr;
+    if (avformat_open_input(&ctx, input.c_str(), nullptr, nullptr) < 0)
+    {
+      fprintf(stderr, "Could not open '%s'\n", input.c_str());
+      return false;
+    }
+
+    bool probed = avformat_find_stream_info(ctx, nullptr) >= 0;
+    for (unsigned int i = 0; probed && i < ctx->nb_streams; i++)
+    {
+      profile.codecs.push_back(ctx->streams[i]->codecpar->codec_id);
+    }
+    avformat_close_input(&ctx);
+
+    std::error_code ec;
+    std::string extension = fs::path(input).extension().string();
+    profile.directory = options.workDir.string();
+    profile.extension = extension.empty() ? extension : extension.substr(1);
+    // A trim never exceeds its input, so the input size covers every duration
+    profile.preallocateBytes = static_cast<int64_t>(fs::file_size(input, ec));
+    return probed;
+  }
+
+  bool waitForPool(ReplayBufferPro::OutputPool &pool)
+  {
+    auto deadline = std::chrono::steady_clock::now() + POOL_READY_TIMEOUT;
+    while (pool.readyCount() == 0)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        fprintf(stderr, "Output pool did not prepare a file in time\n");
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  bool runTrim(const std::string &input, int duration, const std::string &path, ReplayBufferPro::OutputPool *pool,
+               const Options &options, Result &result)
+  {
+    fs::path inputPath(input);
+    fs::path output = options.workDir /
+                      (inputPath.stem().string() + "_trimmed_" + std::to_string(duration) +
+                       inputPath.extension().string());
+
+    std::vector<double> samples;
+    samples.reserve(options.iterations);
+
+    for (int i = 0; i < options.iterations; i++)
+    {
+      // File preparation happens ahead of the save in the plugin, so it stays out of the timing
+      if (pool && !waitForPool(*pool))
+      {
+        return false;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      bool trimmed = false;
+      if (pool)
+      {
+        std::unique_ptr<ReplayBufferPro::PrewarmedOutput> prewarmed = pool->acquire(output.string());
+        trimmed = prewarmed && ReplayBufferPro::VideoTrimmer::trimToLastSeconds(input, output.string(), duration,
+                                                                                prewarmed.get());
+      }
+      else
+      {
+        trimmed = ReplayBufferPro::VideoTrimmer::trimToLastSeconds(input, output.string(), duration);
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      std::error_code ec;
+      fs::remove(output, ec);
+      if (pool)
+      {
+        pool->refill();
+      }
+
+      if (!trimmed)
+      {
+        fprintf(stderr, "Trim of '%s' to %d seconds (%s) failed\n", input.c_str(), duration, path.c_str());
+        return false;
+      }
+      samples.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    size_t mid = samples.size() / 2;
+
+    result.fixture = inputPath.filename().string();
+    result.duration = duration;
+    result.path = path;
+    result.iterations = static_cast<int>(samples.size());
+    result.medianMs = (samples.size() % 2) ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2.0;
+    result.meanMs = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    result.minMs = samples.front();
+    return true;
+  }
+
+  bool writeReport(const std::string &path, const std::vector<Result> &results)
+  {
+    std::ofstream report(path, std::ios::trunc);
+    if (!report)
+    {
+      fprintf(stderr, "Could not open report '%s'\n", path.c_str());
+      return false;
+    }
+
+    report << "fixture,duration,path,iterations,median_ms,mean_ms,min_ms\n";
+    for (const Result &result : results)
+    {
+      report << result.fixture << ',' << result.duration << ',' << result.path << ',' << result.iterations << ','
+             << result.medianMs << ',' << result.meanMs << ',' << result.minMs << '\n';
+    }
+    return true;
+  }
+
+  // Relative distance between the median and the fastest run, used as a rough run-to-run noise band
+  double spreadPercent(const Result &result)
+  {
+    return result.medianMs > 0.0 ? (result.medianMs - result.minMs) / result.medianMs * 100.0 : 0.0;
+  }
+
+  const char *deltaVerdict(double delta, double noise)
+  {
+    return std::abs(delta) <= noise ? "noise" : (delta < 0.0 ? "faster" : "slower");
+  }
+
+  void printPathDeltas(const std::vector<Result> &results)
+  {
+    printf("\n| fixture | duration (s) | direct median (ms) | prewarmed median (ms) | delta | noise | verdict |\n");
+    printf("|---|---:|---:|---:|---:|---:|---|\n");
+    for (const Result &direct : results)
+    {
+      auto prewarmed = std::find_if(results.begin(), results.end(), [&direct](const Result &result) {
+        return result.fixture == direct.fixture && result.duration == direct.duration &&
+               result.path == PATH_PREWARMED;
+      });
+      if (direct.path != PATH_DIRECT || prewarmed == results.end() || direct.medianMs <= 0.0)
+      {
+        continue;
+      }
+
+      double delta = (prewarmed->medianMs - direct.medianMs) / direct.medianMs * 100.0;
+      double noise = std::max(spreadPercent(direct), spreadPercent(*prewarmed));
+      printf("| %s | %d | %.2f | %.2f | %+.1f%% | ±%.1f%% | %s |\n", direct.fixture.c_str(), direct.duration,
+             direct.medianMs, prewarmed->medianMs, delta, noise, deltaVerdict(delta, noise));
+    }
+  }
+
+  int runBenchmark(const Options &options)
+  {
+    std::error_code ec;
+    fs::create_directories(options.workDir, ec);
+    if (ec)
+    {
+      fprintf(stderr, "Could not create work directory '%s'\n", options.workDir.string().c_str());
+      return 1;
+    }
+
+    std::vector<std::string> inputs;
+    std::string fixture = (options.workDir / FIXTURE_NAME).string();
+    if (!writeSyntheticFixture(fixture))
+    {
+      return 1;
+    }
+    inputs.push_back(fixture);
+    inputs.insert(inputs.end(), options.inputs.begin(), options.inputs.end());
+
+    bool usePool = std::find(options.paths.begin(), options.paths.end(), PATH_PREWARMED) != options.paths.end();
+
+    std::vector<Result> results;
+    printf("%-32s %8s %10s %6s %12s %12s %12s\n", "fixture", "duration", "path", "runs", "median ms", "mean ms",
+           "min ms");
+
+    for (const std::string &input : inputs)
+    {
+      // One pooled file is enough: every timed trim waits for its replacement first
+      ReplayBufferPro::OutputPool pool(1);
+      if (usePool)
+      {
+        ReplayBufferPro::MuxerProfile profile;
+        if (!probeProfile(input, options, profile))
+        {
+          return 1;
+        }
+        pool.prepare(profile);
+      }
+
+      for (int duration : TRIM_DURATIONS)
+      {
+        for (const std::string &path : options.paths)
+        {
+          Result result;
+          if (!runTrim(input, duration, path, path == PATH_PREWARMED ? &pool : nullptr, options, result))
+          {
+            return 1;
+          }
+          printf("%-32s %8d %10s %6d %12.2f %12.2f %12.2f\n", result.fixture.c_str(), result.duration,
+                 result.path.c_str(), result.iterations, result.medianMs, result.meanMs, result.minMs);
+          results.push_back(result);
+        }
+      }
+
+      pool.drain();
+    }
+
+    fs::remove(fixture, ec);
+
+    if (usePool && options.paths.size() > 1)
+    {
+      printPathDeltas(results);
+    }
+
+    if (!options.reportPath.empty() && !writeReport(options.reportPath, results))
+    {
+      return 1;
+    }
+    return 0;
+  }
+
+  //=============================================================================
+  // COMPARISON
+  //=============================================================================
+
+  using ResultKey = std::tuple<std::string, int, std::string>;
+
+  bool readReport(const std::string &path, std::map<ResultKey, Result> &results)
+  {
+    std::ifstream report(path);
+    if (!report)
+    {
+      fprintf(stderr, "Could not read report '%s'\n", path.c_str());
+      return false;
+    }
+
+    std::string line;
+    std::getline(report, line); // header
+    while (std::getline(report, line))
+    {
+      std::istringstream row(line);
+      std::string field;
+      std::vector<std::string> fields;
+      while (std::getline(row, field, ','))
+      {
+        fields.push_back(field);
+      }
+      if (fields.size() < 7)
+      {
+        continue;
+      }
+
+      Result result;
+      result.fixture = fields[0];
+      result.duration = atoi(fields[1].c_str());
+      result.path = fields[2];
+      result.iterations = atoi(fields[3].c_str());
+      result.medianMs = atof(fields[4].c_str());
+      result.meanMs = atof(fields[5].c_str());
+      result.minMs = atof(fields[6].c_str());
+      results[{result.fixture, result.duration, result.path}] = result;
+    }
+    return true;
+  }
+
+  int runCompare(const Options &options)
+  {
+    std::map<ResultKey, Result> baseline;
+    std::map<ResultKey, Result> candidate;
+    if (!readReport(options.compareBaseline, baseline) || !readReport(options.compareCandidate, candidate))
+    {
+      return 1;
+    }
+
+    double baselineTotal = 0.0;
+    double candidateTotal = 0.0;
+
+    printf("| fixture | duration (s) | path | baseline median (ms) | candidate median (ms) | delta | noise | verdict |\n");
+    printf("|---|---:|---|---:|---:|---:|---:|---|\n");
+    for (const auto &[key, base] : baseline)
+    {
+      auto match = candidate.find(key);
+      if (match == candidate.end() || base.medianMs <= 0.0)
+      {
+        continue;
+      }
+
+      const Result &cand = match->second;
+      double delta = (cand.medianMs - base.medianMs) / base.medianMs * 100.0;
+      double noise = std::max(spreadPercent(base), spreadPercent(cand));
+      baselineTotal += base.medianMs;
+      candidateTotal += cand.medianMs;
+      printf("| %s | %d | %s | %.2f | %.2f | %+.1f%% | ±%.1f%% | %s |\n", base.fixture.c_str(), base.duration,
+             base.path.c_str(), base.medianMs, cand.medianMs, delta, noise, deltaVerdict(delta, noise));
+    }
+
+    if (baselineTotal > 0.0)
+    {
+      printf("| **total** | | | %.2f | %.2f | %+.1f%% | | |\n", baselineTotal, candidateTotal,
+             (candidateTotal - baselineTotal) / baselineTotal * 100.0);
+    }
+    return 0;
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  if (!options.compareBaseline.empty())
+  {
+    return runCompare(options);
+  }
+
+  if (!options.verbose)
+  {
+    base_set_log_handler(quietLogHandler, nullptr);
+  }
+
+  return runBenchmark(options);
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 /**
  * @brief Configuration constants for the Replay Buffer Pro plugin
  */
@@ -33,5 +36,15 @@ namespace ReplayBufferPro
     // File paths
     constexpr const char *TEMP_FILE_SUFFIX = "tmp";
     constexpr const char *BACKUP_FILE_SUFFIX = "bak";
+
+    // Pre-warmed trim outputs
+    // Pooled file name prefix, followed by the owner PID, pool start time, counter and TEMP_FILE_SUFFIX
+    constexpr const char *OUTPUT_POOL_FILE_PREFIX = "replay-buffer-pro-";
+    constexpr size_t OUTPUT_POOL_SIZE = 2;                          // Open files kept ready per replay directory
+    constexpr int OUTPUT_POOL_IO_BUFFER_SIZE = 1024 * 1024;         // 1 MB muxer write buffer
+    constexpr int OUTPUT_POOL_ESTIMATE_SECONDS = 60;                // Footage covered by the space reservation
+    constexpr int64_t OUTPUT_POOL_DEFAULT_PREALLOCATE = 64LL << 20; // 64 MB when the bitrate is unknown
+    constexpr int64_t OUTPUT_POOL_MAX_PREALLOCATE = 512LL << 20;    // 512 MB cap per pooled file
+    constexpr int OUTPUT_POOL_FREE_SPACE_DIVISOR = 20;              // Whole pool reserves at most 1/20 of free space
   } // namespace Config
 } // namespace ReplayBufferPro
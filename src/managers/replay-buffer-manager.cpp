@@ -5,24 +5,56 @@
 
 #include "managers/replay-buffer-manager.hpp"
 #include "managers/settings-manager.hpp"
+#include "config/config.hpp"
 #include "utils/logger.hpp"
+#include "utils/obs-utils.hpp"
 #include "utils/video-trimmer.hpp"
 
 // OBS includes
 #include <util/platform.h>
 
+// STL includes
+#include <algorithm>
+#include <memory>
+
 // Qt includes
 #include <QMessageBox>
 #include <QString>
 
 namespace ReplayBufferPro
 {
+  namespace
+  {
+    /**
+     * @brief Appends an encoder's codec to the profile and accumulates its bitrate
+     * @return false if the codec has no libavcodec equivalent
+     */
+    bool appendEncoder(MuxerProfile &profile, obs_encoder_t *encoder, int64_t &totalKbps)
+    {
+      const char *codecName = obs_encoder_get_codec(encoder);
+      const AVCodecDescriptor *descriptor = codecName ? avcodec_descriptor_get_by_name(codecName) : nullptr;
+      if (!descriptor)
+      {
+        Logger::info("Encoder codec '%s' unknown to libavcodec", codecName ? codecName : "");
+        return false;
+      }
+      profile.codecs.push_back(descriptor->id);
+
+      OBSDataRAII settings(obs_encoder_get_settings(encoder));
+      if (settings.isValid())
+      {
+        totalKbps += obs_data_get_int(settings.get(), "bitrate");
+      }
+      return true;
+    }
+  } // namespace
+
   //=============================================================================
   // CONSTRUCTORS & DESTRUCTOR
   //=============================================================================
 
   ReplayBufferManager::ReplayBufferManager(QObject *parent)
-      : QObject(parent), pendingSaveDuration(0)
+      : QObject(parent), pendingSaveDuration(0), outputPool(Config::OUTPUT_POOL_SIZE)
   {
   }
 
@@ -120,9 +152,10 @@ namespace ReplayBufferPro
       Logger::info("Trimming replay buffer save to %d seconds", duration);
 
       std::string outputPath = getTrimmedOutputPath(sourcePath);
+      std::unique_ptr<PrewarmedOutput> prewarmed = outputPool.acquire(outputPath);
 
       // Use libavformat instead of external FFmpeg binary
-      if (!VideoTrimmer::trimToLastSeconds(sourcePath, outputPath, duration))
+      if (!VideoTrimmer::trimToLastSeconds(sourcePath, outputPath, duration, prewarmed.get()))
       {
         throw std::runtime_error("Video trimming failed");
       }
@@ -136,6 +169,76 @@ namespace ReplayBufferPro
     {
       Logger::error("Failed to trim replay: %s", e.what());
     }
+
+    // Schedule a replacement for the consumed output so the next save is pre-warmed too
+    outputPool.refill();
+  }
+
+  //=============================================================================
+  // OUTPUT PRE-WARMING
+  //=============================================================================
+
+  void ReplayBufferManager::prepareOutputs()
+  {
+    MuxerProfile profile;
+    if (!getMuxerProfile(profile))
+    {
+      Logger::info("Replay output not describable; trim outputs will be created on save");
+      releaseOutputs();
+      return;
+    }
+
+    Logger::info("Pre-warming %zu '.%s' trim outputs in %s (%zu streams, %lld bytes reserved each)",
+                 Config::OUTPUT_POOL_SIZE, profile.extension.c_str(), profile.directory.c_str(),
+                 profile.codecs.size(), static_cast<long long>(profile.preallocateBytes));
+    outputPool.prepare(profile);
+  }
+
+  void ReplayBufferManager::releaseOutputs()
+  {
+    outputPool.drain();
+  }
+
+  bool ReplayBufferManager::getMuxerProfile(MuxerProfile &profile)
+  {
+    obs_output_t *output = obs_frontend_get_replay_buffer_output();
+    if (!output)
+    {
+      return false;
+    }
+
+    {
+      OBSDataRAII settings(obs_output_get_settings(output));
+      if (settings.isValid())
+      {
+        profile.directory = obs_data_get_string(settings.get(), "directory");
+        profile.extension = obs_data_get_string(settings.get(), "extension");
+      }
+    }
+    bool described = !profile.directory.empty() && !profile.extension.empty();
+
+    // Stream order matches the muxed file: video first, then each audio track
+    int64_t totalKbps = 0;
+    obs_encoder_t *videoEncoder = obs_output_get_video_encoder(output);
+    described = described && videoEncoder && appendEncoder(profile, videoEncoder, totalKbps);
+
+    for (size_t i = 0; described && i < MAX_OUTPUT_AUDIO_ENCODERS; i++)
+    {
+      obs_encoder_t *audioEncoder = obs_output_get_audio_encoder(output, i);
+      if (audioEncoder)
+      {
+        described = appendEncoder(profile, audioEncoder, totalKbps);
+      }
+    }
+
+    obs_output_release(output);
+
+    // Reserve roughly a typical clip's worth of data at the configured bitrate
+    profile.preallocateBytes = totalKbps > 0
+                                   ? std::min(totalKbps * 125 * Config::OUTPUT_POOL_ESTIMATE_SECONDS,
+                                              Config::OUTPUT_POOL_MAX_PREALLOCATE)
+                                   : Config::OUTPUT_POOL_DEFAULT_PREALLOCATE;
+    return described;
   }
 
 } // namespace ReplayBufferPro
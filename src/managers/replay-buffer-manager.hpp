@@ -22,6 +22,7 @@
 
 // Local includes
 #include "utils/video-trimmer.hpp"
+#include "utils/output-pool.hpp"
 
 namespace ReplayBufferPro
 {
@@ -89,11 +90,29 @@ namespace ReplayBufferPro
      */
     void trimReplayBuffer(const char *sourcePath, int duration);
 
+    //=========================================================================
+    // OUTPUT PRE-WARMING
+    //=========================================================================
+    /**
+     * @brief Prepares trim outputs for the active replay buffer
+     *
+     * Reads the replay buffer's directory, container and encoders and fills
+     * the output pool in the background, so a save only copies packets.
+     * Call when the replay buffer has started.
+     */
+    void prepareOutputs();
+
+    /**
+     * @brief Removes all pre-warmed outputs, call when the replay buffer stops
+     */
+    void releaseOutputs();
+
   private:
     //=========================================================================
     // MEMBER VARIABLES
     //=========================================================================
     std::atomic<int> pendingSaveDuration; ///< Duration to save when buffer save completes (atomic for thread safety)
+    OutputPool outputPool;                ///< Pre-warmed trim outputs in the replay directory
 
     //=========================================================================
     // HELPER METHODS
@@ -104,6 +123,13 @@ namespace ReplayBufferPro
      * @return Trimmed file path
      */
     std::string getTrimmedOutputPath(const char *sourcePath);
+
+    /**
+     * @brief Builds the muxer profile of the running replay buffer output
+     * @param profile Receives directory, container, codecs and preallocation size
+     * @return true if the output and all of its encoders could be described
+     */
+    bool getMuxerProfile(MuxerProfile &profile);
   };
 
 } // namespace ReplayBufferPro
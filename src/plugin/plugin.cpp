@@ -142,12 +142,18 @@ namespace ReplayBufferPro
 			if (plugin->hotkeyManager) {
 				plugin->hotkeyManager->saveHotkeySettings();
 			}
+			plugin->replayManager->releaseOutputs();
 			break;
 		case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTING:
 			plugin->settingsMonitorTimer->stop();
 			QMetaObject::invokeMethod(plugin, "updateBufferLengthUIState", Qt::QueuedConnection);
 			break;
+		case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STARTED:
+			// Output settings and encoders are final once the buffer is running
+			plugin->replayManager->prepareOutputs();
+			break;
 		case OBS_FRONTEND_EVENT_REPLAY_BUFFER_STOPPED:
+			plugin->replayManager->releaseOutputs();
 			plugin->settingsMonitorTimer->start();
 			QMetaObject::invokeMethod(plugin, "updateBufferLengthUIState", Qt::QueuedConnection);
 			QMetaObject::invokeMethod(plugin, "loadBufferLength", Qt::QueuedConnection);
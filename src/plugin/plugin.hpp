@@ -193,7 +193,8 @@ namespace ReplayBufferPro
      * 
      * Handles OBS events related to replay buffer state changes:
      * - Buffer starting/stopping: Updates UI state
-     * - Buffer started/stopped: Updates UI and settings monitoring
+     * - Buffer started/stopped: Updates UI and settings monitoring,
+     *   prepares or releases pre-warmed trim outputs
      * - Buffer saved: Handles segment trimming if needed
      * Uses Qt's event system to safely update UI from any thread.
      */
@@ -0,0 +1,642 @@
+/**
+ * @file output-pool.cpp
+ * @brief Implementation of the pre-warmed trim output pool
+ * @author Joshua Potter
+ * @copyright GPL v2 or later
+ *
+ * Pooled files are created in the replay buffer directory as soon as the
+ * buffer starts, with disk space reserved up front and a muxer context
+ * attached through custom IO. Trimming into one of them and renaming it into
+ * place avoids output context allocation, file creation and directory lookups
+ * on the save path.
+ */
+
+#include "utils/output-pool.hpp"
+#include "utils/logger.hpp"
+#include "config/config.hpp"
+
+// OBS includes
+#include <util/platform.h>
+
+// Platform includes (space reservation)
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// STL includes
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace ReplayBufferPro
+{
+  namespace
+  {
+    /**
+     * @brief Reserves disk space for a file without changing its size
+     */
+    bool reserveSpace(FILE *file, int64_t bytes)
+    {
+      if (bytes <= 0)
+      {
+        return true;
+      }
+
+#if defined(_WIN32)
+      HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+      FILE_ALLOCATION_INFO info = {};
+      info.AllocationSize.QuadPart = bytes;
+      return SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info)) != 0;
+#elif defined(__APPLE__)
+      fstore_t store = {};
+      store.fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL;
+      store.fst_posmode = F_PEOFPOSMODE;
+      store.fst_length = bytes;
+      if (fcntl(fileno(file), F_PREALLOCATE, &store) != -1)
+      {
+        return true;
+      }
+      // Contiguous space not available, accept a fragmented reservation
+      store.fst_flags = F_ALLOCATEALL;
+      return fcntl(fileno(file), F_PREALLOCATE, &store) != -1;
+#elif defined(__linux__)
+      return fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, bytes) == 0;
+#else
+      return false;
+#endif
+    }
+
+    /**
+     * @brief Drops the space reservation if the whole pool would take too much of the free space
+     *
+     * The replay dump itself needs the room; pooled files then only save the
+     * file creation cost.
+     */
+    void limitReservation(MuxerProfile &profile, size_t capacity, bool &logged)
+    {
+      if (profile.preallocateBytes <= 0)
+      {
+        return;
+      }
+
+      uint64_t freeBytes = os_get_free_disk_space(profile.directory.c_str());
+      uint64_t poolBytes = static_cast<uint64_t>(profile.preallocateBytes) * capacity;
+      if (poolBytes <= freeBytes / Config::OUTPUT_POOL_FREE_SPACE_DIVISOR)
+      {
+        return;
+      }
+
+      if (!logged)
+      {
+        Logger::warning("Only %llu MB free in '%s', pre-warming trim outputs without reserving space",
+                        static_cast<unsigned long long>(freeBytes >> 20), profile.directory.c_str());
+        logged = true;
+      }
+      profile.preallocateBytes = 0;
+    }
+
+    /**
+     * @brief Returns reserved space past the end of the written data
+     *
+     * Windows releases it when the handle closes; POSIX reservations can
+     * outlive the handle, so truncate to the current size. The file must be
+     * flushed first or the size excludes buffered data.
+     */
+    bool releaseUnusedSpace(FILE *file)
+    {
+#if !defined(_WIN32)
+      struct stat info;
+      return fstat(fileno(file), &info) == 0 && ftruncate(fileno(file), info.st_size) == 0;
+#else
+      (void)file;
+      return true;
+#endif
+    }
+
+    unsigned long currentProcessId()
+    {
+#if defined(_WIN32)
+      return GetCurrentProcessId();
+#else
+      return static_cast<unsigned long>(getpid());
+#endif
+    }
+
+    bool processRunning(unsigned long pid)
+    {
+#if defined(_WIN32)
+      HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+      if (!process)
+      {
+        // Access denied still means the process exists
+        return GetLastError() != ERROR_INVALID_PARAMETER;
+      }
+      DWORD exitCode = 0;
+      bool running = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+      CloseHandle(process);
+      return running;
+#else
+      return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+    }
+
+    /**
+     * @brief Reads the owning process ID from a pooled file name
+     *
+     * Pooled files are named <prefix><pid>-<pool start>-<n>.<suffix>.
+     */
+    bool parseOwnerProcess(const std::string &path, unsigned long &pid)
+    {
+      size_t slash = path.find_last_of("/\\");
+      std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+      size_t prefixLength = strlen(Config::OUTPUT_POOL_FILE_PREFIX);
+      if (name.compare(0, prefixLength, Config::OUTPUT_POOL_FILE_PREFIX) != 0)
+      {
+        return false;
+      }
+
+      const char *digits = name.c_str() + prefixLength;
+      char *end = nullptr;
+      unsigned long long value = strtoull(digits, &end, 10);
+      if (end == digits || *end != '-' || value == 0 || value > UINT32_MAX)
+      {
+        return false;
+      }
+      pid = static_cast<unsigned long>(value);
+      return true;
+    }
+
+    std::string normalizePath(std::string path)
+    {
+      std::replace(path.begin(), path.end(), '\\', '/');
+      while (path.size() > 1 && path.back() == '/')
+      {
+        path.pop_back();
+      }
+      return path;
+    }
+  } // namespace
+
+  //=============================================================================
+  // PREWARMED OUTPUT
+  //=============================================================================
+
+  PrewarmedOutput::PrewarmedOutput(const MuxerProfile &profile, const std::string &path)
+      : profile(profile), path(path)
+  {
+  }
+
+  PrewarmedOutput::~PrewarmedOutput()
+  {
+    if (context)
+    {
+      context->pb = nullptr;
+      avformat_free_context(context);
+      context = nullptr;
+    }
+    closeFile();
+    if (!path.empty())
+    {
+      os_unlink(path.c_str());
+    }
+  }
+
+  std::unique_ptr<PrewarmedOutput> PrewarmedOutput::create(const MuxerProfile &profile, const std::string &path)
+  {
+    std::unique_ptr<PrewarmedOutput> output(new PrewarmedOutput(profile, path));
+    if (!output->openFile() || !output->createContext())
+    {
+      return nullptr;
+    }
+    return output;
+  }
+
+  bool PrewarmedOutput::openFile()
+  {
+    file = os_fopen(path.c_str(), "wb");
+    if (!file)
+    {
+      Logger::warning("Could not create pre-warmed output file '%s'", path.c_str());
+      path.clear();
+      return false;
+    }
+
+    // The AVIO buffer already batches writes; unbuffered stdio makes every
+    // write error surface in writePacket instead of at fclose
+    setvbuf(file, nullptr, _IONBF, 0);
+
+    if (!reserveSpace(file, profile.preallocateBytes))
+    {
+      // Not fatal: the file still saves the open/create cost
+      Logger::warning("Could not reserve %lld bytes for '%s'",
+                      static_cast<long long>(profile.preallocateBytes), path.c_str());
+    }
+    return true;
+  }
+
+  bool PrewarmedOutput::createContext()
+  {
+    // Resolve the muxer from the container extension, as the trimmer does for its output path
+    std::string probeName = "output." + profile.extension;
+    int ret = avformat_alloc_output_context2(&context, nullptr, nullptr, probeName.c_str());
+    if (ret < 0 || !context)
+    {
+      Logger::warning("No muxer available for '.%s' outputs", profile.extension.c_str());
+      return false;
+    }
+
+    // Muxers such as HLS open their own files from the URL and would ignore the pooled file
+    if (context->oformat->flags & AVFMT_NOFILE)
+    {
+      Logger::info("Muxer '%s' writes its own files, not pre-warming '.%s' outputs", context->oformat->name,
+                   profile.extension.c_str());
+      return false;
+    }
+
+    // The probe name only selected the muxer; the real path is set in takeContext()
+    av_freep(&context->url);
+
+    for (AVCodecID codecId : profile.codecs)
+    {
+      if (avformat_query_codec(context->oformat, codecId, FF_COMPLIANCE_NORMAL) == 0)
+      {
+        Logger::warning("Muxer '%s' cannot store %s streams", context->oformat->name,
+                        avcodec_get_name(codecId));
+        return false;
+      }
+
+      AVStream *stream = avformat_new_stream(context, nullptr);
+      if (!stream)
+      {
+        return false;
+      }
+      stream->codecpar->codec_type = avcodec_get_type(codecId);
+      stream->codecpar->codec_id = codecId;
+    }
+
+    unsigned char *buffer = static_cast<unsigned char *>(av_malloc(Config::OUTPUT_POOL_IO_BUFFER_SIZE));
+    if (!buffer)
+    {
+      return false;
+    }
+
+    io = avio_alloc_context(buffer, Config::OUTPUT_POOL_IO_BUFFER_SIZE, 1, this, nullptr, writePacket, seekFile);
+    if (!io)
+    {
+      av_free(buffer);
+      return false;
+    }
+
+    context->pb = io;
+    context->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return true;
+  }
+
+  bool PrewarmedOutput::matches(AVFormatContext *inputCtx) const
+  {
+    if (inputCtx->nb_streams != profile.codecs.size())
+    {
+      return false;
+    }
+
+    for (unsigned int i = 0; i < inputCtx->nb_streams; i++)
+    {
+      if (inputCtx->streams[i]->codecpar->codec_id != profile.codecs[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  AVFormatContext *PrewarmedOutput::takeContext(AVFormatContext *inputCtx, const std::string &outputPath)
+  {
+    if (!context)
+    {
+      return nullptr;
+    }
+
+    if (!matches(inputCtx))
+    {
+      // Keep the open file, only the pre-created streams are wrong
+      Logger::info("Replay stream layout differs from encoder profile, rebuilding pre-warmed muxer");
+
+      AVFormatContext *rebuilt = nullptr;
+      if (avformat_alloc_output_context2(&rebuilt, context->oformat, nullptr, nullptr) < 0 || !rebuilt)
+      {
+        return nullptr;
+      }
+      rebuilt->pb = io;
+      rebuilt->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+      context->pb = nullptr;
+      avformat_free_context(context);
+      context = rebuilt;
+    }
+
+    av_freep(&context->url);
+    context->url = av_strdup(outputPath.c_str());
+    if (!context->url)
+    {
+      return nullptr;
+    }
+
+    AVFormatContext *taken = context;
+    context = nullptr;
+    return taken;
+  }
+
+  bool PrewarmedOutput::finish(AVFormatContext *outputCtx, const std::string &outputPath, bool success)
+  {
+    if (outputCtx && outputCtx->pb == io)
+    {
+      outputCtx->pb = nullptr;
+    }
+
+    if (path.empty())
+    {
+      return false; // Already finished
+    }
+
+    // Only rename once every byte has reached the file; the caller deletes the source on success
+    bool written = closeFile();
+
+    if (success && written && os_rename(path.c_str(), outputPath.c_str()) == 0)
+    {
+      path.clear();
+      return true;
+    }
+
+    os_unlink(path.c_str());
+    path.clear();
+    return false;
+  }
+
+  bool PrewarmedOutput::closeFile()
+  {
+    bool written = true;
+
+    if (io)
+    {
+      avio_flush(io);
+      written = !io->error;
+      av_freep(&io->buffer);
+      avio_context_free(&io);
+    }
+
+    if (file)
+    {
+      written = fflush(file) == 0 && written;
+      written = releaseUnusedSpace(file) && written;
+      written = fclose(file) == 0 && written;
+      file = nullptr;
+    }
+
+    if (!written)
+    {
+      Logger::error("Failed to write pre-warmed output '%s'", path.c_str());
+    }
+    return written;
+  }
+
+#if LIBAVFORMAT_VERSION_MAJOR < 61
+  int PrewarmedOutput::writePacket(void *opaque, uint8_t *buf, int size)
+#else
+  int PrewarmedOutput::writePacket(void *opaque, const uint8_t *buf, int size)
+#endif
+  {
+    auto *self = static_cast<PrewarmedOutput *>(opaque);
+    if (fwrite(buf, 1, size, self->file) != static_cast<size_t>(size))
+    {
+      return AVERROR(EIO);
+    }
+    return size;
+  }
+
+  int64_t PrewarmedOutput::seekFile(void *opaque, int64_t offset, int whence)
+  {
+    auto *self = static_cast<PrewarmedOutput *>(opaque);
+
+    if (whence & AVSEEK_SIZE)
+    {
+      int64_t position = os_ftelli64(self->file);
+      if (os_fseeki64(self->file, 0, SEEK_END) != 0)
+      {
+        return AVERROR(EIO);
+      }
+      int64_t size = os_ftelli64(self->file);
+      os_fseeki64(self->file, position, SEEK_SET);
+      return size;
+    }
+
+    if (os_fseeki64(self->file, offset, whence & ~AVSEEK_FORCE) != 0)
+    {
+      return AVERROR(EIO);
+    }
+    return os_ftelli64(self->file);
+  }
+
+  //=============================================================================
+  // OUTPUT POOL
+  //=============================================================================
+
+  OutputPool::OutputPool(size_t capacity)
+      : capacity(capacity),
+        owner(std::to_string(currentProcessId()) + "-" + std::to_string(os_gettime_ns()))
+  {
+    worker = std::thread([this]() { run(); });
+  }
+
+  OutputPool::~OutputPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      active = false;
+      stopping = true;
+      generation++;
+      std::move(ready.begin(), ready.end(), std::back_inserter(retired));
+      ready.clear();
+    }
+    wakeup.notify_one();
+    worker.join();
+  }
+
+  void OutputPool::prepare(const MuxerProfile &newProfile)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::move(ready.begin(), ready.end(), std::back_inserter(retired));
+      ready.clear();
+      generation++;
+      profile = newProfile;
+      profile.directory = normalizePath(profile.directory);
+      active = true;
+      cleanupRequested = true;
+      fillRequested = true;
+    }
+    wakeup.notify_one();
+  }
+
+  std::unique_ptr<PrewarmedOutput> OutputPool::acquire(const std::string &outputPath)
+  {
+    std::string normalized = normalizePath(outputPath);
+    size_t slash = normalized.find_last_of('/');
+    size_t dot = normalized.find_last_of('.');
+    std::string directory = slash == std::string::npos ? std::string() : normalized.substr(0, slash);
+    std::string extension = (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+                                ? std::string()
+                                : normalized.substr(dot + 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active || ready.empty() || directory != profile.directory || extension != profile.extension)
+    {
+      return nullptr;
+    }
+
+    std::unique_ptr<PrewarmedOutput> output = std::move(ready.back());
+    ready.pop_back();
+    return output;
+  }
+
+  size_t OutputPool::readyCount()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ready.size();
+  }
+
+  void OutputPool::refill()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!active)
+      {
+        return;
+      }
+      fillRequested = true;
+    }
+    wakeup.notify_one();
+  }
+
+  void OutputPool::drain()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      active = false;
+      generation++;
+      std::move(ready.begin(), ready.end(), std::back_inserter(retired));
+      ready.clear();
+    }
+    wakeup.notify_one();
+  }
+
+  void OutputPool::run()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      wakeup.wait(lock, [this]() { return stopping || cleanupRequested || fillRequested || !retired.empty(); });
+
+      // Closing and unlinking retired files happens outside the lock
+      if (!retired.empty())
+      {
+        std::vector<std::unique_ptr<PrewarmedOutput>> released;
+        released.swap(retired);
+        lock.unlock();
+        released.clear();
+        lock.lock();
+        continue;
+      }
+
+      if (stopping)
+      {
+        return;
+      }
+
+      if (cleanupRequested)
+      {
+        cleanupRequested = false;
+        std::string directory = profile.directory;
+        lock.unlock();
+        removeStaleFiles(directory);
+        lock.lock();
+        continue;
+      }
+
+      // One file at a time, so a drain or new profile takes effect between files
+      fillRequested = false;
+      bool lowSpaceLogged = false;
+      while (active && !stopping && retired.empty() && ready.size() < capacity)
+      {
+        MuxerProfile target = profile;
+        uint64_t fillGeneration = generation;
+        std::string path = target.directory + "/" + Config::OUTPUT_POOL_FILE_PREFIX + owner + "-" +
+                           std::to_string(fileCounter++) + "." + Config::TEMP_FILE_SUFFIX;
+
+        lock.unlock();
+        limitReservation(target, capacity, lowSpaceLogged);
+        std::unique_ptr<PrewarmedOutput> output = PrewarmedOutput::create(target, path);
+        lock.lock();
+
+        if (!output)
+        {
+          break; // Retried on the next refill request
+        }
+        if (!active || generation != fillGeneration)
+        {
+          retired.push_back(std::move(output));
+          break;
+        }
+        ready.push_back(std::move(output));
+      }
+    }
+  }
+
+  void OutputPool::removeStaleFiles(const std::string &directory) const
+  {
+    // Each leftover can hold up to OUTPUT_POOL_MAX_PREALLOCATE bytes of reserved space
+    std::string pattern = directory + "/" + Config::OUTPUT_POOL_FILE_PREFIX + "*." + Config::TEMP_FILE_SUFFIX;
+
+    os_glob_t *glob = nullptr;
+    if (os_glob(pattern.c_str(), 0, &glob) != 0)
+    {
+      return; // No matches
+    }
+
+    unsigned long self = currentProcessId();
+    for (size_t i = 0; i < glob->gl_pathc; i++)
+    {
+      const os_globent &entry = glob->gl_pathv[i];
+      unsigned long pid = 0;
+      // Only files whose owner has exited are leftovers; a live owner (this process or another
+      // OBS instance using the same directory) still has them pooled or being renamed by a trim
+      if (entry.directory || !parseOwnerProcess(entry.path, pid) || pid == self || processRunning(pid))
+      {
+        continue;
+      }
+
+      if (os_unlink(entry.path) == 0)
+      {
+        Logger::info("Removed stale pre-warmed output '%s'", entry.path);
+      }
+      else
+      {
+        Logger::warning("Could not remove stale pre-warmed output '%s'", entry.path);
+      }
+    }
+
+    os_globfree(glob);
+  }
+
+} // namespace ReplayBufferPro
@@ -0,0 +1,197 @@
+/**
+ * @file output-pool.hpp
+ * @brief Pool of pre-warmed trim output files and muxer contexts
+ * @author Joshua Potter
+ * @copyright GPL v2 or later
+ *
+ * Keeps a small number of already-open, preallocated files in the replay
+ * buffer directory, each paired with a muxer context prepared from the active
+ * encoder configuration, so a save only has to open the dump and copy packets.
+ */
+
+#pragma once
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+// STL includes
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ReplayBufferPro
+{
+  /**
+   * @brief Muxer configuration captured from the replay buffer output when it starts
+   */
+  struct MuxerProfile
+  {
+    std::string directory;         ///< Replay buffer output directory
+    std::string extension;         ///< Container extension without the dot (mkv, mp4, ...)
+    std::vector<AVCodecID> codecs; ///< Stream codecs in file order (video first, then audio tracks)
+    int64_t preallocateBytes = 0;  ///< Disk space reserved for each pooled file
+  };
+
+  /**
+   * @brief An open, preallocated output file with a prepared muxer context
+   *
+   * The muxer writes through a custom AVIOContext on the already-open file, so
+   * no file creation happens on the save path. On success the file is renamed
+   * to the final output path; on failure it is removed.
+   */
+  class PrewarmedOutput
+  {
+  public:
+    /**
+     * @brief Creates the file and muxer context for a profile
+     *
+     * Fails for muxers that open their own files (AVFMT_NOFILE), since they
+     * would not write to the pooled file.
+     *
+     * @param profile Muxer configuration to prepare
+     * @param path Temporary path inside the profile directory
+     * @return Prepared output, or nullptr if the file or muxer could not be set up
+     */
+    static std::unique_ptr<PrewarmedOutput> create(const MuxerProfile &profile, const std::string &path);
+
+    /**
+     * @brief Closes and removes the file if it was never committed
+     */
+    ~PrewarmedOutput();
+
+    /**
+     * @brief Hands the prepared muxer context to the trimmer
+     *
+     * If the input's stream layout differs from the captured profile (for
+     * example a track was added), the context is rebuilt without streams but
+     * keeps writing to the same open file.
+     *
+     * @param inputCtx Opened input the output will be copied from
+     * @param outputPath Final output file path, used as the context URL
+     * @return Output context owned by the caller, or nullptr if unusable
+     */
+    AVFormatContext *takeContext(AVFormatContext *inputCtx, const std::string &outputPath);
+
+    /**
+     * @brief Detaches the file from the muxer and moves it into place
+     *
+     * Must be called before the caller frees the context returned by
+     * takeContext(). Safe to call more than once.
+     *
+     * @param outputCtx Context returned by takeContext()
+     * @param outputPath Final output file path
+     * @param success Whether the trailer was written successfully
+     * @return true if the file now exists at outputPath
+     */
+    bool finish(AVFormatContext *outputCtx, const std::string &outputPath, bool success);
+
+    // Prevent copying
+    PrewarmedOutput(const PrewarmedOutput &) = delete;
+    PrewarmedOutput &operator=(const PrewarmedOutput &) = delete;
+
+  private:
+    PrewarmedOutput(const MuxerProfile &profile, const std::string &path);
+
+    bool openFile();
+    bool createContext();
+    bool matches(AVFormatContext *inputCtx) const;
+    bool closeFile();
+
+#if LIBAVFORMAT_VERSION_MAJOR < 61
+    static int writePacket(void *opaque, uint8_t *buf, int size);
+#else
+    static int writePacket(void *opaque, const uint8_t *buf, int size);
+#endif
+    static int64_t seekFile(void *opaque, int64_t offset, int whence);
+
+    MuxerProfile profile;               ///< Configuration the muxer was prepared for
+    std::string path;                   ///< Temporary file path
+    FILE *file = nullptr;               ///< Open file handle (holds the preallocation)
+    AVIOContext *io = nullptr;          ///< Custom IO writing to file
+    AVFormatContext *context = nullptr; ///< Prepared muxer until taken
+  };
+
+  /**
+   * @brief Keeps a small set of PrewarmedOutput instances ready for the replay directory
+   *
+   * All file creation and removal happens on one worker thread owned by the
+   * pool, so the public methods only update state and never block on disk I/O.
+   */
+  class OutputPool
+  {
+  public:
+    /**
+     * @brief Constructor, starts the worker thread
+     * @param capacity Number of files to keep ready
+     */
+    explicit OutputPool(size_t capacity);
+
+    /**
+     * @brief Destructor, drains the pool and joins the worker
+     */
+    ~OutputPool();
+
+    /**
+     * @brief Replaces the profile and schedules a fill
+     *
+     * Pooled files in the profile directory whose owning process is no longer
+     * running (an earlier session that did not shut down cleanly) are removed
+     * before the pool is filled.
+     *
+     * @param profile Muxer configuration of the active replay buffer
+     */
+    void prepare(const MuxerProfile &profile);
+
+    /**
+     * @brief Takes a ready output for a trim target, if one matches
+     * @param outputPath Final output path of the trim
+     * @return Prepared output, or nullptr if the directory or container does not match
+     */
+    std::unique_ptr<PrewarmedOutput> acquire(const std::string &outputPath);
+
+    /**
+     * @brief Number of outputs currently ready to hand out
+     */
+    size_t readyCount();
+
+    /**
+     * @brief Schedules topping the pool back up to capacity
+     */
+    void refill();
+
+    /**
+     * @brief Stops refilling and schedules removal of every pooled file
+     */
+    void drain();
+
+    // Prevent copying
+    OutputPool(const OutputPool &) = delete;
+    OutputPool &operator=(const OutputPool &) = delete;
+
+  private:
+    void run();
+    void removeStaleFiles(const std::string &directory) const;
+
+    std::mutex mutex;                                       ///< Guards all members below
+    std::condition_variable wakeup;                         ///< Signals the worker that there is work
+    size_t capacity;                                        ///< Target number of ready files
+    bool active = false;                                    ///< Whether a profile is set
+    bool stopping = false;                                  ///< Set by the destructor to end the worker
+    bool fillRequested = false;                             ///< Worker should top up the pool
+    bool cleanupRequested = false;                          ///< Worker should remove stale files first
+    std::string owner;                                      ///< "<pid>-<start time>" part of pooled file names
+    uint64_t generation = 0;                                ///< Bumped on prepare/drain to drop stale fills
+    uint64_t fileCounter = 0;                               ///< Unique suffix for pooled file names
+    MuxerProfile profile;                                   ///< Current configuration
+    std::vector<std::unique_ptr<PrewarmedOutput>> ready;   ///< Files ready to hand out
+    std::vector<std::unique_ptr<PrewarmedOutput>> retired; ///< Files the worker has to close and remove
+    std::thread worker;                                     ///< Creates and removes pooled files
+  };
+
+} // namespace ReplayBufferPro
@@ -9,6 +9,7 @@
  */
 
 #include "video-trimmer.hpp"
+#include "output-pool.hpp"
 #include "logger.hpp"
 
 extern "C" {
@@ -36,7 +37,8 @@ namespace ReplayBufferPro {
 
 bool VideoTrimmer::trimToLastSeconds(const std::string& inputPath,
                                    const std::string& outputPath,
-                                   int durationSeconds) {
+                                   int durationSeconds,
+                                   PrewarmedOutput* prewarmed) {
     initializeFFmpeg();
     
     AVFormatContext* inputCtx = nullptr;
@@ -102,12 +104,21 @@ bool VideoTrimmer::trimToLastSeconds(const std::string& inputPath,
         Logger::info("Trimming from %.2f seconds to end (%.2f seconds total)", 
                     startTime, totalDuration - startTime);
         
-        // Create output context
-        ret = avformat_alloc_output_context2(&outputCtx, nullptr, nullptr, outputPath.c_str());
-        if (ret < 0) {
-            Logger::error("Could not create output context: %s", av_error_string(ret).c_str());
-            avformat_close_input(&inputCtx);
-            return false;
+        // Create output context (pre-warmed outputs carry an open file and prepared muxer)
+        if (prewarmed) {
+            outputCtx = prewarmed->takeContext(inputCtx, outputPath);
+            if (!outputCtx) {
+                Logger::warning("Pre-warmed output unusable, creating output file directly");
+                prewarmed = nullptr;
+            }
+        }
+        if (!outputCtx) {
+            ret = avformat_alloc_output_context2(&outputCtx, nullptr, nullptr, outputPath.c_str());
+            if (ret < 0) {
+                Logger::error("Could not create output context: %s", av_error_string(ret).c_str());
+                avformat_close_input(&inputCtx);
+                return false;
+            }
         }
         
         // Setup output streams to match input
@@ -117,7 +128,7 @@ bool VideoTrimmer::trimToLastSeconds(const std::string& inputPath,
         }
         
         // Open output file
-        if (!(outputCtx->oformat->flags & AVFMT_NOFILE)) {
+        if (!prewarmed && !(outputCtx->oformat->flags & AVFMT_NOFILE)) {
             ret = avio_open(&outputCtx->pb, outputPath.c_str(), AVIO_FLAG_WRITE);
             if (ret < 0) {
                 Logger::error("Could not open output file '%s': %s", 
@@ -287,6 +298,12 @@ bool VideoTrimmer::trimToLastSeconds(const std::string& inputPath,
             goto cleanup;
         }
         
+        // Move the pre-warmed file into place (detaches it from outputCtx)
+        if (prewarmed && !prewarmed->finish(outputCtx, outputPath, true)) {
+            Logger::error("Could not move pre-warmed output to '%s'", outputPath.c_str());
+            goto cleanup;
+        }
+        
         // Cleanup
         avformat_close_input(&inputCtx);
         if (outputCtx && !(outputCtx->oformat->flags & AVFMT_NOFILE)) {
@@ -301,6 +318,9 @@ bool VideoTrimmer::trimToLastSeconds(const std::string& inputPath,
         if (inputCtx) {
             avformat_close_input(&inputCtx);
         }
+        if (prewarmed && outputCtx) {
+            prewarmed->finish(outputCtx, outputPath, false);
+        }
         if (outputCtx) {
             if (outputCtx->pb && !(outputCtx->oformat->flags & AVFMT_NOFILE)) {
                 avio_closep(&outputCtx->pb);
@@ -372,7 +392,8 @@ bool VideoTrimmer::setupOutputStreams(AVFormatContext* inputCtx,
     // Copy all streams from input to output
     for (unsigned int i = 0; i < inputCtx->nb_streams; i++) {
         AVStream* inputStream = inputCtx->streams[i];
-        AVStream* outputStream = avformat_new_stream(outputCtx, nullptr);
+        AVStream* outputStream = i < outputCtx->nb_streams ? outputCtx->streams[i]
+                                                           : avformat_new_stream(outputCtx, nullptr);
         
         if (!outputStream) {
             Logger::error("Failed to allocate output stream %d", i);
@@ -21,6 +21,8 @@ extern "C" {
 
 namespace ReplayBufferPro {
 
+class PrewarmedOutput;
+
 /**
  * @brief Video trimming utility class using libavformat
  * 
@@ -36,14 +38,20 @@ public:
      * N seconds, and creates a new trimmed video file using stream copy
      * (no re-encoding) for maximum performance.
      * 
+     * When a pre-warmed output is supplied, its open file and prepared muxer
+     * are used instead of allocating a context and creating the output file,
+     * and the result is renamed to outputPath once the trailer is written.
+     * 
      * @param inputPath Input video file path
      * @param outputPath Output video file path  
      * @param durationSeconds Duration in seconds to keep from the end
+     * @param prewarmed Optional pre-warmed output (may be nullptr)
      * @return true if successful, false otherwise
      */
     static bool trimToLastSeconds(const std::string& inputPath, 
                                  const std::string& outputPath,
-                                 int durationSeconds);
+                                 int durationSeconds,
+                                 PrewarmedOutput* prewarmed = nullptr);
 
 private:
     /**
@@ -70,7 +78,8 @@ private:
      * @brief Setup output streams to match input streams
      * 
      * Creates output streams that match the input streams, copying
-     * codec parameters for stream copy operation.
+     * codec parameters for stream copy operation. Streams already present
+     * in a pre-warmed output context are reused.
      * 
      * @param inputCtx Input format context
      * @param outputCtx Output format context